@@ -0,0 +1,73 @@
+#include <cstring>
+#include "file_reader.h"
+
+FileReader::FileReader(size_t max_record_size, size_t max_pending)
+        : max_record_size(max_record_size)
+        , max_pending(max_pending == 0 ? 1 : max_pending)
+        {}
+
+void FileReader::pushRecord() {
+    if (!partial.empty() && partial.back() == '\r')
+        partial.pop_back();
+
+    if (skipping)
+        ready.push_back(Record{std::string(), true});
+    else if (!partial.empty())
+        ready.push_back(Record{std::move(partial), false});
+
+    partial.clear();
+    skipping = false;
+}
+
+size_t FileReader::feed(const char *data, size_t size) {
+    size_t consumed = 0;
+
+    while (consumed < size && ready.size() < max_pending) {
+        const char *begin = data + consumed;
+        auto end = static_cast<const char *>(
+                std::memchr(begin, '\n', size - consumed));
+        size_t length = (end == nullptr ? data + size : end) - begin;
+
+        if (!skipping) {
+            if (partial.size() + length > max_record_size) {
+                skipping = true;
+                partial.clear();
+                partial.shrink_to_fit();
+            } else {
+                partial.append(begin, length);
+            }
+        }
+
+        consumed += length;
+        if (end != nullptr) {
+            consumed++;
+            pushRecord();
+        }
+    }
+
+    return consumed;
+}
+
+void FileReader::finish() {
+    if (skipping || !partial.empty())
+        pushRecord();
+}
+
+bool FileReader::hasNext() const noexcept {
+    return !ready.empty();
+}
+
+size_t FileReader::pending() const noexcept {
+    return ready.size();
+}
+
+File FileReader::next() {
+    if (ready.empty()) throw NoPendingRecordException();
+
+    Record record = std::move(ready.front());
+    ready.pop_front();
+
+    if (record.oversized) throw RecordTooLongException();
+
+    return File(std::move(record.description));
+}
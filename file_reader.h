@@ -0,0 +1,47 @@
+#ifndef PLAYLIST_FILE_READER_H
+#define PLAYLIST_FILE_READER_H
+
+#include <deque>
+#include <string>
+#include "playlist.h"
+
+// Splits a byte stream into newline-terminated File records. Input may be fed
+// in arbitrary chunks; at most max_record_size bytes of an unfinished record
+// and max_pending finished records are held at any time.
+class FileReader {
+    struct Record {
+        std::string description;
+        bool oversized;
+    };
+
+    const size_t max_record_size;
+    const size_t max_pending;
+
+    std::string partial;
+    bool skipping = false;
+    std::deque<Record> ready;
+
+    void pushRecord();
+
+public:
+    explicit FileReader(size_t max_record_size = 1 << 16,
+                        size_t max_pending = 64);
+
+    // Consumes bytes until the pending queue is full and returns how many
+    // were consumed; the caller should drain with next() and feed the rest.
+    size_t feed(const char *data, size_t size);
+
+    // Marks the end of input, turning a trailing unterminated record into
+    // a pending one.
+    void finish();
+
+    bool hasNext() const noexcept;
+
+    size_t pending() const noexcept;
+
+    // Parses the oldest pending record. A corrupt or oversized record throws
+    // and is dropped, so reading can continue with the following one.
+    File next();
+};
+
+#endif
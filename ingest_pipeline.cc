@@ -0,0 +1,193 @@
+#include "ingest_pipeline.h"
+
+namespace {
+    using steady_clock = std::chrono::steady_clock;
+
+    void addElapsed(std::atomic<std::chrono::nanoseconds::rep> &timer,
+                    steady_clock::time_point since) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                steady_clock::now() - since);
+        timer.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    }
+}
+
+IngestPipeline::IngestPipeline(opener_t open_file,
+                               std::shared_ptr<Playlist> target,
+                               size_t queue_capacity, size_t chunk_size,
+                               size_t batch_size)
+        : open_file(std::move(open_file))
+        , target(std::move(target))
+        , chunk_size(chunk_size == 0 ? 1 : chunk_size)
+        , batch_size(batch_size == 0 ? 1 : batch_size)
+        , chunks(queue_capacity == 0 ? 1 : queue_capacity)
+        , files(queue_capacity == 0 ? 1 : queue_capacity)
+        , pieces(queue_capacity == 0 ? 1 : queue_capacity)
+        {}
+
+void IngestPipeline::fail() noexcept {
+    if (!failure_claimed.exchange(true))
+        failure = std::current_exception();
+    failed.store(true);
+    chunks.wake();
+    files.wake();
+    pieces.wake();
+}
+
+void IngestPipeline::readStage(std::istream &input) {
+    try {
+        while (true) {
+            auto start = steady_clock::now();
+            std::string chunk(chunk_size, '\0');
+            input.read(&chunk[0], chunk.size());
+            chunk.resize(input.gcount());
+            addElapsed(read_time, start);
+
+            if (chunk.empty()) break;
+
+            bytes_read.fetch_add(chunk.size(), std::memory_order_relaxed);
+            if (!chunks.push(chunk, failed)) return;
+        }
+
+        std::string end;
+        chunks.push(end, failed);
+    } catch (...) {
+        fail();
+    }
+}
+
+void IngestPipeline::parseStage() {
+    try {
+        FileReader reader;
+        std::string chunk;
+        bool done = false;
+
+        while (!done) {
+            if (!chunks.pop(chunk, failed)) return;
+
+            auto start = steady_clock::now();
+            size_t offset = 0;
+            done = chunk.empty();
+            if (done) reader.finish();
+
+            do {
+                offset += reader.feed(chunk.data() + offset,
+                                      chunk.size() - offset);
+
+                while (reader.hasNext()) {
+                    std::optional<File> file;
+                    try {
+                        file.emplace(reader.next());
+                    } catch (PlayerException const &e) {
+                        records_rejected.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+
+                    records_parsed.fetch_add(1, std::memory_order_relaxed);
+                    addElapsed(parse_time, start);
+                    if (!files.push(file, failed)) return;
+                    start = steady_clock::now();
+                }
+            } while (offset < chunk.size());
+
+            addElapsed(parse_time, start);
+        }
+
+        std::optional<File> end;
+        files.push(end, failed);
+    } catch (...) {
+        fail();
+    }
+}
+
+void IngestPipeline::openStage() {
+    try {
+        std::optional<File> file;
+
+        while (files.pop(file, failed) && file) {
+            auto start = steady_clock::now();
+            piece_ptr piece;
+            try {
+                piece = open_file(*file);
+            } catch (PlayerException const &e) {
+                records_rejected.fetch_add(1, std::memory_order_relaxed);
+            }
+            addElapsed(open_time, start);
+
+            if (piece) {
+                pieces_opened.fetch_add(1, std::memory_order_relaxed);
+                if (!pieces.push(piece, failed)) return;
+            }
+        }
+
+        piece_ptr end;
+        pieces.push(end, failed);
+    } catch (...) {
+        fail();
+    }
+}
+
+void IngestPipeline::appendStage() {
+    try {
+        std::vector<piece_ptr> batch;
+        batch.reserve(batch_size);
+        piece_ptr piece;
+        bool done = false;
+
+        while (!done) {
+            if (!pieces.pop(piece, failed)) return;
+
+            done = !piece;
+            if (!done) batch.push_back(std::move(piece));
+
+            while (!done && batch.size() < batch_size && pieces.tryPop(piece)) {
+                done = !piece;
+                if (!done) batch.push_back(std::move(piece));
+            }
+
+            if (batch.empty()) continue;
+
+            auto start = steady_clock::now();
+            target->add(batch);
+            addElapsed(append_time, start);
+
+            pieces_appended.fetch_add(batch.size(),
+                                      std::memory_order_relaxed);
+            batch.clear();
+        }
+    } catch (...) {
+        fail();
+    }
+}
+
+void IngestPipeline::run(std::istream &input) {
+    std::thread reader([this, &input] { readStage(input); });
+    std::thread parser([this] { parseStage(); });
+    std::thread opener([this] { openStage(); });
+
+    appendStage();
+
+    reader.join();
+    parser.join();
+    opener.join();
+
+    if (failure) std::rethrow_exception(failure);
+}
+
+IngestStats IngestPipeline::stats() const noexcept {
+    using std::chrono::nanoseconds;
+
+    return IngestStats{
+            bytes_read.load(),
+            records_parsed.load(),
+            records_rejected.load(),
+            pieces_opened.load(),
+            pieces_appended.load(),
+            chunks.size(),
+            files.size(),
+            pieces.size(),
+            nanoseconds(read_time.load()),
+            nanoseconds(parse_time.load()),
+            nanoseconds(open_time.load()),
+            nanoseconds(append_time.load())
+    };
+}
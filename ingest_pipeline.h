@@ -0,0 +1,88 @@
+#ifndef PLAYLIST_INGEST_PIPELINE_H
+#define PLAYLIST_INGEST_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <optional>
+#include "file_reader.h"
+#include "spsc_queue.h"
+
+struct IngestStats {
+    size_t bytes_read;
+    size_t records_parsed;
+    size_t records_rejected;
+    size_t pieces_opened;
+    size_t pieces_appended;
+
+    size_t chunk_queue_depth;
+    size_t file_queue_depth;
+    size_t piece_queue_depth;
+
+    std::chrono::nanoseconds read_time;
+    std::chrono::nanoseconds parse_time;
+    std::chrono::nanoseconds open_time;
+    std::chrono::nanoseconds append_time;
+};
+
+// Reads File descriptions from a stream and appends the pieces opened by
+// open_file, typically a player's openFile, to a playlist in input order.
+// Reading, parsing and opening run on their own threads connected by
+// bounded queues; appending runs on the calling thread. Records rejected
+// by File or by open_file are counted and skipped. Zero sizes are treated
+// as 1.
+class IngestPipeline {
+    using piece_ptr = std::shared_ptr<Piece>;
+    using opener_t = std::function<piece_ptr(const File &)>;
+    using counter_t = std::atomic<size_t>;
+    using timer_t = std::atomic<std::chrono::nanoseconds::rep>;
+
+    opener_t open_file;
+    std::shared_ptr<Playlist> target;
+    const size_t chunk_size;
+    const size_t batch_size;
+
+    SpscQueue<std::string> chunks;
+    SpscQueue<std::optional<File>> files;
+    SpscQueue<piece_ptr> pieces;
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr failure;
+    std::atomic<bool> failure_claimed{false};
+
+    counter_t bytes_read{0};
+    counter_t records_parsed{0};
+    counter_t records_rejected{0};
+    counter_t pieces_opened{0};
+    counter_t pieces_appended{0};
+
+    timer_t read_time{0};
+    timer_t parse_time{0};
+    timer_t open_time{0};
+    timer_t append_time{0};
+
+    void fail() noexcept;
+
+    void readStage(std::istream &input);
+
+    void parseStage();
+
+    void openStage();
+
+    void appendStage();
+
+public:
+    IngestPipeline(opener_t open_file, std::shared_ptr<Playlist> target,
+                   size_t queue_capacity = 256, size_t chunk_size = 1 << 16,
+                   size_t batch_size = 64);
+
+    // Blocks until the whole stream has been appended. May be called once.
+    void run(std::istream &input);
+
+    // Safe to call from another thread while run() is in progress.
+    IngestStats stats() const noexcept;
+};
+
+#endif
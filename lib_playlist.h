@@ -2,5 +2,7 @@
 #define PLAYLIST_LIB_PLAYLIST_H
 
 #include "playlist.h"
+#include "file_reader.h"
+#include "ingest_pipeline.h"
 
 #endif
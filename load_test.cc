@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <streambuf>
+#include <thread>
+#include "lib_playlist.h"
+
+using steady_clock = std::chrono::steady_clock;
+
+namespace {
+    struct Options {
+        size_t threads = 4;
+        double seconds = 5;
+        double rate = 0;
+        size_t songs = 2000;
+        size_t movies = 1000;
+        double corrupt = 0.05;
+        size_t min_size = 16;
+        size_t max_size = 1024;
+        size_t width = 8;
+        size_t depth = 4;
+        size_t open_weight = 40;
+        size_t add_weight = 15;
+        size_t remove_weight = 15;
+        size_t play_weight = 30;
+        unsigned seed = 2020;
+        bool compressed = false;
+    };
+
+    enum Operation {
+        OPEN,
+        ADD,
+        REMOVE,
+        PLAY,
+        OPERATIONS
+    };
+
+    const char *const OPERATION_NAMES[OPERATIONS] = {
+            "openFile", "add", "remove", "play"
+    };
+
+    struct ThreadResults {
+        std::vector<long long> latencies[OPERATIONS];
+        size_t failures[OPERATIONS] = {};
+    };
+
+    class NullBuffer : public std::streambuf {
+    protected:
+        int overflow(int c) override {
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char *, std::streamsize n) override {
+            return n;
+        }
+    };
+
+    bool parseOption(const char *arg, Options &options) {
+        const char *eq = std::strchr(arg, '=');
+        if (std::strncmp(arg, "--", 2) != 0 || eq == nullptr) return false;
+
+        std::string name(arg + 2, eq);
+        std::string value(eq + 1);
+
+        if (name == "threads") options.threads = std::stoul(value);
+        else if (name == "seconds") options.seconds = std::stod(value);
+        else if (name == "rate") options.rate = std::stod(value);
+        else if (name == "songs") options.songs = std::stoul(value);
+        else if (name == "movies") options.movies = std::stoul(value);
+        else if (name == "corrupt") options.corrupt = std::stod(value);
+        else if (name == "min-size") options.min_size = std::stoul(value);
+        else if (name == "max-size") options.max_size = std::stoul(value);
+        else if (name == "width") options.width = std::stoul(value);
+        else if (name == "depth") options.depth = std::stoul(value);
+        else if (name == "open") options.open_weight = std::stoul(value);
+        else if (name == "add") options.add_weight = std::stoul(value);
+        else if (name == "remove") options.remove_weight = std::stoul(value);
+        else if (name == "play") options.play_weight = std::stoul(value);
+        else if (name == "seed") options.seed = std::stoul(value);
+        else if (name == "compressed") options.compressed = value == "1";
+        else return false;
+
+        return true;
+    }
+
+    // Rejects combinations that would leave nothing to pick from.
+    bool validOptions(const Options &options) {
+        return options.width > 0 && options.songs + options.movies > 0
+               && options.min_size <= options.max_size
+               && options.open_weight + options.add_weight
+                  + options.remove_weight + options.play_weight > 0;
+    }
+
+    void usage(const char *program) {
+        std::cerr << "usage: " << program << " [--name=value]...\n"
+                  << "  threads, seconds, rate (ops/s per thread, 0 = max),\n"
+                  << "  songs, movies, corrupt (fraction), min-size, max-size,\n"
+                  << "  width, depth, open, add, remove, play (weights),\n"
+                  << "  seed, compressed (0/1)\n"
+                  << "  width, songs + movies and the weight total must be\n"
+                  << "  positive, and min-size may not exceed max-size\n";
+    }
+
+    std::string randomText(std::mt19937 &engine, size_t size) {
+        static const char *const words[] = {
+                "love", "night", "baby", "dance", "heart", "fire", "road",
+                "dream", "rain", "gold", "home", "time", "sky", "river"
+        };
+        std::uniform_int_distribution<size_t> word(0, 13);
+        std::string text;
+
+        while (text.size() < size) {
+            text += words[word(engine)];
+            text += text.size() % 7 == 0 ? ", " : " ";
+        }
+        text.resize(size);
+        return text;
+    }
+
+    std::string corrupt(std::mt19937 &engine, std::string description) {
+        switch (engine() % 3) {
+            case 0:
+                return description + "%%";
+            case 1:
+                return description.substr(0, description.find('|'));
+            default:
+                return "video|title:Broken|year:19x9|" + description;
+        }
+    }
+
+    std::vector<std::string> generateCatalog(const Options &options,
+                                             std::mt19937 &engine) {
+        std::uniform_int_distribution<size_t> size(options.min_size,
+                                                   options.max_size);
+        std::uniform_real_distribution<double> chance(0, 1);
+        std::vector<std::string> catalog;
+
+        for (size_t i = 0; i < options.songs + options.movies; i++) {
+            std::string description;
+            if (i < options.songs) {
+                description = "audio|artist:Artist " + std::to_string(i % 97)
+                              + "|title:Song " + std::to_string(i) + "|";
+            } else {
+                description = "video|title:Movie " + std::to_string(i)
+                              + "|year:" + std::to_string(1900 + i % 120) + "|";
+            }
+            description += randomText(engine, size(engine));
+
+            if (chance(engine) < options.corrupt)
+                description = corrupt(engine, std::move(description));
+            catalog.push_back(std::move(description));
+        }
+
+        return catalog;
+    }
+
+    // Builds depth levels of playlists; every playlist above the bottom one
+    // takes width children picked at random from the level below, so
+    // sub-playlists are shared.
+    std::vector<std::vector<std::shared_ptr<Playlist>>>
+    buildPlaylists(const Options &options, Player &player,
+                   const std::vector<std::shared_ptr<Piece>> &pieces,
+                   std::mt19937 &engine) {
+        std::vector<std::vector<std::shared_ptr<Playlist>>> levels(
+                std::max<size_t>(options.depth, 1));
+        size_t count = 1;
+        for (size_t level = 1; level < levels.size(); level++)
+            count = std::min<size_t>(count * options.width, 4096);
+
+        for (size_t level = levels.size(); level-- > 0;) {
+            for (size_t i = 0; i < count; i++) {
+                auto playlist = player.createPlaylist(
+                        "L" + std::to_string(level) + "-" + std::to_string(i));
+                if ((level + i) % 2 == 1)
+                    playlist->setMode(createOddEvenMode());
+
+                for (size_t j = 0; j < options.width; j++) {
+                    if (level + 1 == levels.size() && !pieces.empty())
+                        playlist->add(pieces[engine() % pieces.size()]);
+                    else if (level + 1 < levels.size())
+                        playlist->add(levels[level + 1][
+                                engine() % levels[level + 1].size()]);
+                }
+                levels[level].push_back(playlist);
+            }
+            count = std::max<size_t>(count / std::max<size_t>(options.width, 1), 1);
+        }
+
+        return levels;
+    }
+
+    long long percentile(const std::vector<long long> &sorted, double p) {
+        if (sorted.empty()) return 0;
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        try {
+            if (!parseOption(argv[i], options)) throw std::invalid_argument(argv[i]);
+        } catch (std::exception const &e) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!validOptions(options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ContentStorage storage = options.compressed ? ContentStorage::COMPRESSED
+                                                : ContentStorage::PLAIN;
+    std::mt19937 engine(options.seed);
+    std::vector<std::string> catalog = generateCatalog(options, engine);
+
+    Player player(storage);
+    std::vector<std::shared_ptr<Piece>> pieces;
+    for (const std::string &description : catalog) {
+        try {
+            pieces.push_back(player.openFile(File(description)));
+        } catch (PlayerException const &e) {}
+    }
+
+    auto levels = buildPlaylists(options, player, pieces, engine);
+    auto &bottom = levels.back();
+    std::shared_mutex library_lock;
+
+    size_t weights[OPERATIONS] = {
+            options.open_weight, options.add_weight,
+            options.remove_weight, options.play_weight
+    };
+
+    std::cerr << "catalog: " << catalog.size() << " records, "
+              << pieces.size() << " pieces; root plays "
+              << levels.front().front()->trackCount() << " tracks, "
+              << levels.front().front()->deepMemoryUsage().total()
+              << " bytes\n";
+
+    NullBuffer null_buffer;
+    auto old_buffer = std::cout.rdbuf(&null_buffer);
+
+    std::vector<ThreadResults> results(options.threads);
+    std::vector<std::thread> workers;
+    auto start = steady_clock::now();
+    auto deadline = start + std::chrono::duration_cast<steady_clock::duration>(
+            std::chrono::duration<double>(options.seconds));
+
+    for (size_t t = 0; t < options.threads; t++) {
+        workers.emplace_back([&, t] {
+            ThreadResults &mine = results[t];
+            std::mt19937 local(options.seed + 1 + t);
+            std::discrete_distribution<int> pick(weights, weights + OPERATIONS);
+            Player local_player(storage);
+            auto next = steady_clock::now();
+            auto interval = options.rate > 0
+                    ? std::chrono::duration_cast<steady_clock::duration>(
+                            std::chrono::duration<double>(1 / options.rate))
+                    : steady_clock::duration::zero();
+
+            while (steady_clock::now() < deadline) {
+                auto scheduled = next;
+                if (options.rate > 0) {
+                    std::this_thread::sleep_until(next);
+                    next += interval;
+                }
+
+                // At a fixed rate, latency counts from the scheduled start,
+                // so time spent behind schedule is not omitted.
+                Operation operation = static_cast<Operation>(pick(local));
+                auto began = options.rate > 0 ? scheduled : steady_clock::now();
+                bool ok = true;
+
+                try {
+                    switch (operation) {
+                        case OPEN: {
+                            File file(catalog[local() % catalog.size()]);
+                            local_player.openFile(file);
+                            break;
+                        }
+                        case ADD: {
+                            std::unique_lock<std::shared_mutex> lock(library_lock);
+                            auto &target = bottom[local() % bottom.size()];
+                            if (pieces.empty()) break;
+                            target->add(pieces[local() % pieces.size()],
+                                        local() % (target->trackCount() + 1));
+                            break;
+                        }
+                        case REMOVE: {
+                            std::unique_lock<std::shared_mutex> lock(library_lock);
+                            auto &target = bottom[local() % bottom.size()];
+                            if (target->trackCount() > 0)
+                                target->remove(local() % target->trackCount());
+                            break;
+                        }
+                        default: {
+                            std::shared_lock<std::shared_mutex> lock(library_lock);
+                            auto &level = levels[local() % levels.size()];
+                            level[local() % level.size()]->play();
+                        }
+                    }
+                } catch (PlayerException const &e) {
+                    ok = false;
+                }
+
+                auto elapsed = steady_clock::now() - began;
+                mine.latencies[operation].push_back(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                elapsed).count());
+                if (!ok) mine.failures[operation]++;
+            }
+        });
+    }
+
+    for (auto &worker : workers) worker.join();
+    double elapsed = std::chrono::duration<double>(
+            steady_clock::now() - start).count();
+    std::cout.rdbuf(old_buffer);
+
+    std::cout << std::left << std::setw(10) << "operation"
+              << std::right << std::setw(10) << "count"
+              << std::setw(10) << "failed"
+              << std::setw(14) << "ops/s"
+              << std::setw(12) << "p50 us"
+              << std::setw(12) << "p99 us"
+              << std::setw(12) << "p999 us" << "\n";
+
+    for (int operation = 0; operation < OPERATIONS; operation++) {
+        std::vector<long long> merged;
+        size_t failures = 0;
+        for (auto &thread_results : results) {
+            auto &latencies = thread_results.latencies[operation];
+            merged.insert(merged.end(), latencies.begin(), latencies.end());
+            failures += thread_results.failures[operation];
+        }
+        std::sort(merged.begin(), merged.end());
+
+        std::cout << std::left << std::setw(10) << OPERATION_NAMES[operation]
+                  << std::right << std::setw(10) << merged.size()
+                  << std::setw(10) << failures
+                  << std::setw(14) << std::fixed << std::setprecision(1)
+                  << merged.size() / elapsed
+                  << std::setw(12) << percentile(merged, 0.50) / 1000.0
+                  << std::setw(12) << percentile(merged, 0.99) / 1000.0
+                  << std::setw(12) << percentile(merged, 0.999) / 1000.0
+                  << "\n";
+    }
+
+    return 0;
+}
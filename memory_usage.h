@@ -0,0 +1,40 @@
+#ifndef PLAYLIST_MEMORY_USAGE_H
+#define PLAYLIST_MEMORY_USAGE_H
+
+#include <string>
+#include <vector>
+
+// Approximate byte counts; heap sizes are estimated from capacities, so
+// allocator overhead is not included.
+struct MemoryUsage {
+    size_t metadata = 0;
+    size_t contents = 0;
+    size_t structure = 0;
+
+    size_t total() const noexcept {
+        return metadata + contents + structure;
+    }
+
+    MemoryUsage &operator+=(const MemoryUsage &other) noexcept {
+        metadata += other.metadata;
+        contents += other.contents;
+        structure += other.structure;
+        return *this;
+    }
+};
+
+// Reference counts and vtable pointer of a make_shared allocation.
+const size_t SHARED_CONTROL_BLOCK_BYTES = sizeof(void *) + 2 * sizeof(int);
+
+inline size_t heapBytes(const std::string &s) noexcept {
+    const char *begin = reinterpret_cast<const char *>(&s);
+    bool local = s.data() >= begin && s.data() < begin + sizeof(s);
+    return local ? 0 : s.capacity() + 1;
+}
+
+template <typename T>
+size_t heapBytes(const std::vector<T> &v) noexcept {
+    return v.capacity() * sizeof(T);
+}
+
+#endif
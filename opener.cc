@@ -2,17 +2,32 @@
 #include "opener.h"
 
 Song::Song(std::unordered_map<std::string, std::string> metadata,
-           std::string contents)
+           std::string contents, ContentStorage storage)
         : artist(metadata["artist"])
         , title(metadata["title"])
-        , contents(std::move(contents))
+        , contents(std::move(contents), storage)
         {}
 
-void Song::play() const noexcept {
+void Song::play() const {
+    const std::string &text = contents.get();
     std::cout << "Song [" << artist << ", " << title << "]: ";
-    std::cout << contents << "\n";
+    std::cout << text << "\n";
 };
 
+bool Song::render(std::string &output) const {
+    output.append("Song [").append(artist).append(", ").append(title);
+    output.append("]: ").append(contents.get()).append("\n");
+    return true;
+}
+
+MemoryUsage Song::memoryUsage() const {
+    MemoryUsage usage;
+    usage.metadata = heapBytes(artist) + heapBytes(title);
+    usage.contents = contents.heapBytes();
+    usage.structure = sizeof(Song);
+    return usage;
+}
+
 std::string Movie::decipher(std::string line) const {
     char answer[line.size() + 1];
     int help;
@@ -36,17 +51,32 @@ std::string Movie::decipher(std::string line) const {
 }
 
 Movie::Movie(std::unordered_map<std::string, std::string> metadata,
-             std::string contents)
+             std::string contents, ContentStorage storage)
         : title(metadata["title"])
         , year(metadata["year"])
-        , contents(decipher(std::move(contents)))
+        , contents(decipher(std::move(contents)), storage)
         {}
 
-void Movie::play() const noexcept {
+void Movie::play() const {
+    const std::string &text = contents.get();
     std::cout << "Movie [" << title << ", " << year << "]: ";
-    std::cout << contents << "\n";
+    std::cout << text << "\n";
 };
 
+bool Movie::render(std::string &output) const {
+    output.append("Movie [").append(title).append(", ").append(year);
+    output.append("]: ").append(contents.get()).append("\n");
+    return true;
+}
+
+MemoryUsage Movie::memoryUsage() const {
+    MemoryUsage usage;
+    usage.metadata = heapBytes(title) + heapBytes(year);
+    usage.contents = contents.heapBytes();
+    usage.structure = sizeof(Movie);
+    return usage;
+}
+
 std::shared_ptr<Piece> SongOpener::open (
         std::unordered_map<std::string, std::string> metadata,
         std::string contents) const
@@ -59,7 +89,7 @@ std::shared_ptr<Piece> SongOpener::open (
         throw CorruptFileException();
 
     return std::make_shared<Song>(
-            Song(std::move(metadata), std::move(contents)));
+            Song(std::move(metadata), std::move(contents), storage));
 }
 
 void MovieOpener::checkIsNumber(std::string line) const {
@@ -82,5 +112,5 @@ std::shared_ptr<Piece> MovieOpener::open(
     checkIsNumber(metadata["year"]);
 
     return std::make_shared<Movie>(
-            Movie(std::move(metadata), std::move(contents)));
+            Movie(std::move(metadata), std::move(contents), storage));
 }
@@ -1,33 +1,45 @@
 #ifndef PLAYLIST_OPENER_H
 #define PLAYLIST_OPENER_H
 
+#include <string_view>
 #include <unordered_map>
 #include "playable.h"
+#include "stored_contents.h"
 
 class Song : public Piece {
     const std::string artist;
     const std::string title;
-    const std::string contents;
+    const StoredContents contents;
 
 public:
     Song(std::unordered_map<std::string, std::string> metadata,
-         std::string contents);
+         std::string contents,
+         ContentStorage storage = ContentStorage::PLAIN);
 
-    void play() const noexcept override;
+    void play() const override;
+
+    bool render(std::string &output) const override;
+
+    MemoryUsage memoryUsage() const override;
 };
 
 class Movie : public Piece {
     const std::string title;
     const std::string year;
-    const std::string contents;
+    const StoredContents contents;
 
     std::string decipher(std::string line) const;
 
 public:
     Movie(std::unordered_map<std::string, std::string> metadata,
-          std::string contents);
+          std::string contents,
+          ContentStorage storage = ContentStorage::PLAIN);
+
+    void play() const override;
 
-    void play() const noexcept override;
+    bool render(std::string &output) const override;
+
+    MemoryUsage memoryUsage() const override;
 };
 
 class Opener {
@@ -40,7 +52,14 @@ public:
 };
 
 class SongOpener : public Opener {
+    const ContentStorage storage;
+
 public:
+    static constexpr std::string_view type_tag = "audio";
+
+    explicit SongOpener(ContentStorage storage = ContentStorage::PLAIN)
+            : storage(storage) {}
+
     std::shared_ptr<Piece>
     open(std::unordered_map<std::string, std::string> metadata,
          std::string contents) const override;
@@ -48,9 +67,16 @@ public:
 
 class MovieOpener : public Opener {
 private:
+    const ContentStorage storage;
+
     void checkIsNumber(std::string line) const;
 
 public:
+    static constexpr std::string_view type_tag = "video";
+
+    explicit MovieOpener(ContentStorage storage = ContentStorage::PLAIN)
+            : storage(storage) {}
+
     std::shared_ptr<Piece>
     open(std::unordered_map<std::string, std::string> metadata,
          std::string contents) const override;
@@ -1,56 +1,395 @@
+#include <unordered_map>
 #include "playable.h"
 
+CompositeEdit CompositeEdit::insert(std::shared_ptr<Piece> elem,
+                                    size_t position) {
+    return CompositeEdit(Kind::INSERT, position, std::move(elem));
+}
+
+CompositeEdit CompositeEdit::insert(std::shared_ptr<CompositePlayable> elem,
+                                    size_t position) {
+    return CompositeEdit(Kind::INSERT, position, std::move(elem));
+}
+
+CompositeEdit CompositeEdit::remove(size_t position) {
+    return CompositeEdit(Kind::REMOVE, position, nullptr);
+}
+
+MemoryUsage Playable::memoryUsage() const {
+    return MemoryUsage();
+}
+
+MemoryUsage Playable::deepMemoryUsage() const {
+    MemoryUsage usage;
+    visited_t visited{this};
+    collectMemoryUsage(usage, visited);
+    return usage;
+}
+
+void Playable::collectMemoryUsage(MemoryUsage &usage, visited_t &) const {
+    usage += memoryUsage();
+}
+
+size_t Piece::trackCount() const noexcept {
+    return 1;
+}
+
+bool Piece::render(std::string &) const {
+    return false;
+}
+
+CompositePlayable::~CompositePlayable() {
+    for (auto child : child_composites)
+        child->removeParent(this);
+}
+
 size_t CompositePlayable::size() const {
     return child_components.size();
 }
 
 bool CompositePlayable::reachable(CompositePlayable *looked_up) const {
+    std::unordered_set<const CompositePlayable *> visited;
+    return reachable(looked_up, visited);
+}
+
+bool CompositePlayable::reachable(
+        CompositePlayable *looked_up,
+        std::unordered_set<const CompositePlayable *> &visited) const {
     if (this == looked_up) return true;
+    if (!visited.insert(this).second) return false;
 
     for (auto elem : child_composites)
-        if (elem->reachable(looked_up))
+        if (elem->reachable(looked_up, visited))
             return true;
 
     return false;
 }
 
+void CompositePlayable::addParent(CompositePlayable *parent) {
+    for (auto &entry : parents) {
+        if (entry.first == parent) {
+            entry.second++;
+            return;
+        }
+    }
+    parents.emplace_back(parent, 1);
+}
+
+void CompositePlayable::removeParent(CompositePlayable *parent) noexcept {
+    for (auto it = parents.begin(); it != parents.end(); ++it) {
+        if (it->first == parent) {
+            if (--it->second == 0) parents.erase(it);
+            return;
+        }
+    }
+}
+
+void CompositePlayable::collectAncestors(
+        std::vector<CompositePlayable *> &order,
+        std::unordered_set<const CompositePlayable *> &visited) {
+    if (!visited.insert(this).second) return;
+
+    for (auto &entry : parents)
+        entry.first->collectAncestors(order, visited);
+    order.push_back(this);
+}
+
+std::vector<CompositePlayable *> CompositePlayable::ancestorsInOrder() {
+    std::vector<CompositePlayable *> order;
+    std::unordered_set<const CompositePlayable *> visited;
+
+    collectAncestors(order, visited);
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+void CompositePlayable::shiftTrackCount(
+        const std::vector<CompositePlayable *> &ancestors,
+        ptrdiff_t delta) noexcept {
+    invalidateTrackOffsets();
+    if (delta == 0) return;
+
+    pending_tracks = delta;
+    for (auto node : ancestors) {
+        ptrdiff_t shift = node->pending_tracks;
+        node->pending_tracks = 0;
+        if (shift == 0) continue;
+
+        node->track_count += shift;
+        for (auto &entry : node->parents) {
+            entry.first->pending_tracks +=
+                    shift * static_cast<ptrdiff_t>(entry.second);
+            entry.first->shiftTrackOffsets(node, shift);
+        }
+    }
+}
+
+void CompositePlayable::invalidateTrackOffsets() const noexcept {
+    track_tree_valid = false;
+}
+
+void CompositePlayable::shiftTrackOffsets(const CompositePlayable *child,
+                                          ptrdiff_t shift) const noexcept {
+    if (!track_tree_valid) return;
+
+    auto it = played_composites.find(child);
+    if (it == played_composites.end()) {
+        track_tree_valid = false;
+        return;
+    }
+
+    for (size_t played : it->second)
+        for (size_t i = played + 1; i < track_tree.size(); i += i & (~i + 1))
+            track_tree[i] += shift;
+}
+
+size_t CompositePlayable::playedPosition(size_t played_position) const {
+    return played_position;
+}
+
+void CompositePlayable::buildTrackOffsets() const {
+    track_tree.assign(size() + 1, 0);
+    played_composites.clear();
+
+    for (size_t i = 0; i < size(); i++) {
+        const playable_ptr &child = child_components[playedPosition(i)];
+        track_tree[i + 1] = child->trackCount();
+
+        auto composite = dynamic_cast<const CompositePlayable *>(child.get());
+        if (composite != nullptr) played_composites[composite].push_back(i);
+    }
+
+    for (size_t i = 1; i < track_tree.size(); i++) {
+        size_t parent = i + (i & (~i + 1));
+        if (parent < track_tree.size()) track_tree[parent] += track_tree[i];
+    }
+
+    track_tree_valid = true;
+}
+
+size_t CompositePlayable::playedChildAt(size_t &position) const {
+    if (position >= track_count) throw OutOfBoundsException();
+    if (!track_tree_valid) buildTrackOffsets();
+
+    size_t played = 0, step = 1;
+    while (step * 2 < track_tree.size()) step *= 2;
+
+    for (; step > 0; step /= 2) {
+        if (played + step < track_tree.size()
+            && track_tree[played + step] <= position) {
+            played += step;
+            position -= track_tree[played];
+        }
+    }
+
+    return played;
+}
+
 void CompositePlayable::add(piece_ptr elem, size_t position) {
+    if (!elem) throw NullElementException();
     if (position > size()) throw OutOfBoundsException();
 
+    auto ancestors = ancestorsInOrder();
     child_components.insert(child_components.begin() + position, elem);
+    shiftTrackCount(ancestors, 1);
 }
 
 void CompositePlayable::add(piece_ptr elem) {
+    if (!elem) throw NullElementException();
+
+    auto ancestors = ancestorsInOrder();
     child_components.push_back(elem);
+    shiftTrackCount(ancestors, 1);
+}
+
+void CompositePlayable::add(const std::vector<piece_ptr> &elems) {
+    for (auto &elem : elems)
+        if (!elem) throw NullElementException();
+
+    auto ancestors = ancestorsInOrder();
+    child_components.insert(child_components.end(),
+                            elems.begin(), elems.end());
+    shiftTrackCount(ancestors, elems.size());
 }
 
 void CompositePlayable::add(composite_ptr elem, size_t position) {
+    if (!elem) throw NullElementException();
     if (elem->reachable(this)) throw LoopingException();
     if (position > size()) throw OutOfBoundsException();
 
+    auto ancestors = ancestorsInOrder();
     child_components.insert(child_components.begin() + position, elem);
     child_composites.push_back(elem.get());
+    elem->addParent(this);
+    shiftTrackCount(ancestors, elem->track_count);
 }
 
 void CompositePlayable::add(composite_ptr elem) {
+    if (!elem) throw NullElementException();
     if (elem->reachable(this)) throw LoopingException();
 
+    auto ancestors = ancestorsInOrder();
     child_components.push_back(elem);
     child_composites.push_back(elem.get());
+    elem->addParent(this);
+    shiftTrackCount(ancestors, elem->track_count);
 }
 
 void CompositePlayable::remove(size_t position) {
     if (position >= size()) throw OutOfBoundsException();
 
+    auto ancestors = ancestorsInOrder();
     auto it = find(child_composites.begin(), child_composites.end(),
                    child_components[position].get());
+    size_t removed_tracks = child_components[position]->trackCount();
 
+    if (it != child_composites.end()) {
+        (*it)->removeParent(this);
+        child_composites.erase(it);
+    }
     child_components.erase(child_components.begin() + position);
-    if (it != child_composites.end()) child_composites.erase(it);
+    shiftTrackCount(ancestors, -static_cast<ptrdiff_t>(removed_tracks));
 }
 
 void CompositePlayable::remove() {
     if (size() == 0) throw OutOfBoundsException();
 
     remove(size() - 1);
-}
\ No newline at end of file
+}
+
+void CompositePlayable::applyBatch(const std::vector<CompositeEdit> &edits) {
+    std::vector<bool> removed(size(), false);
+    std::vector<size_t> inserts_before(size() + 2, 0);
+    std::unordered_map<CompositePlayable *, size_t> inserted_composites;
+    std::unordered_set<const CompositePlayable *> visited;
+    std::vector<CompositePlayable *> composites(edits.size(), nullptr);
+    ptrdiff_t delta = 0;
+
+    for (size_t i = 0; i < edits.size(); i++) {
+        const CompositeEdit &edit = edits[i];
+
+        if (edit.kind == CompositeEdit::Kind::REMOVE) {
+            if (edit.position >= size()) throw OutOfBoundsException();
+            if (removed[edit.position]) throw ConflictingEditException();
+
+            removed[edit.position] = true;
+            delta -= static_cast<ptrdiff_t>(
+                    child_components[edit.position]->trackCount());
+        } else {
+            if (edit.position > size()) throw OutOfBoundsException();
+            if (!edit.elem) throw NullElementException();
+
+            composites[i] = dynamic_cast<CompositePlayable *>(edit.elem.get());
+            if (composites[i] != nullptr
+                && composites[i]->reachable(this, visited))
+                throw LoopingException();
+
+            inserts_before[edit.position + 1]++;
+            if (composites[i] != nullptr) inserted_composites[composites[i]]++;
+            delta += static_cast<ptrdiff_t>(edit.elem->trackCount());
+        }
+    }
+
+    for (size_t i = 1; i < inserts_before.size(); i++)
+        inserts_before[i] += inserts_before[i - 1];
+
+    std::vector<size_t> inserts(inserts_before.back());
+    for (size_t i = 0; i < edits.size(); i++)
+        if (edits[i].kind == CompositeEdit::Kind::INSERT)
+            inserts[inserts_before[edits[i].position]++] = i;
+
+    std::vector<playable_ptr> merged_components;
+    merged_components.reserve(size() + inserts.size());
+    std::unordered_map<const Playable *, size_t> removed_composites;
+    auto next_insert = inserts.begin();
+
+    for (size_t position = 0; position <= size(); position++) {
+        while (next_insert != inserts.end()
+               && edits[*next_insert].position == position)
+            merged_components.push_back(edits[*next_insert++].elem);
+
+        if (position == size()) break;
+        if (!removed[position])
+            merged_components.push_back(child_components[position]);
+        else
+            removed_composites[child_components[position].get()]++;
+    }
+
+    std::vector<CompositePlayable *> merged_composites, detached;
+    merged_composites.reserve(child_composites.size() + inserts.size());
+    for (auto composite : child_composites) {
+        auto it = removed_composites.find(composite);
+        if (it != removed_composites.end() && it->second > 0) {
+            it->second--;
+            detached.push_back(composite);
+        } else {
+            merged_composites.push_back(composite);
+        }
+    }
+
+    for (auto &inserted : inserted_composites) {
+        auto &child_parents = inserted.first->parents;
+        child_parents.reserve(child_parents.size() + 1);
+    }
+
+    auto ancestors = ancestorsInOrder();
+
+    for (auto composite : detached)
+        composite->removeParent(this);
+
+    for (size_t i : inserts) {
+        if (composites[i] == nullptr) continue;
+
+        merged_composites.push_back(composites[i]);
+        composites[i]->addParent(this);
+    }
+
+    child_components.swap(merged_components);
+    child_composites.swap(merged_composites);
+    shiftTrackCount(ancestors, delta);
+}
+
+size_t CompositePlayable::trackCount() const noexcept {
+    return track_count;
+}
+
+MemoryUsage CompositePlayable::memoryUsage() const {
+    MemoryUsage usage;
+    usage.structure = heapBytes(child_components) + heapBytes(child_composites)
+                      + heapBytes(parents) + heapBytes(track_tree)
+                      + played_composites.bucket_count() * sizeof(void *);
+
+    for (auto &entry : played_composites)
+        usage.structure += sizeof(entry) + sizeof(void *)
+                           + heapBytes(entry.second);
+    return usage;
+}
+
+void CompositePlayable::collectMemoryUsage(MemoryUsage &usage,
+                                           visited_t &visited) const {
+    usage += memoryUsage();
+
+    for (auto &child : child_components) {
+        if (!visited.insert(child.get()).second) continue;
+
+        usage.structure += SHARED_CONTROL_BLOCK_BYTES;
+        child->collectMemoryUsage(usage, visited);
+    }
+}
+
+CompositePlayable::piece_ptr
+CompositePlayable::trackAt(size_t position) const {
+    const CompositePlayable *node = this;
+
+    while (true) {
+        size_t played = node->playedChildAt(position);
+        const playable_ptr &child =
+                node->child_components[node->playedPosition(played)];
+
+        auto composite = dynamic_cast<const CompositePlayable *>(child.get());
+        if (composite == nullptr)
+            return std::dynamic_pointer_cast<Piece>(child);
+
+        node = composite;
+    }
+}
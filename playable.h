@@ -2,18 +2,72 @@
 #define PLAYLIST_PLAYABLE_H
 
 #include "playable_exception.h"
+#include "memory_usage.h"
 #include <algorithm>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class Playable {
 public:
+    using visited_t = std::unordered_set<const Playable *>;
+
     virtual void play() const = 0;
 
+    // Number of pieces played by play(), counting repeated ones.
+    virtual size_t trackCount() const noexcept = 0;
+
+    // Bytes held by this object alone; children are not included.
+    virtual MemoryUsage memoryUsage() const;
+
+    // Bytes held by this object and everything reachable from it, with
+    // each shared object counted once.
+    MemoryUsage deepMemoryUsage() const;
+
+    virtual void collectMemoryUsage(MemoryUsage &usage,
+                                    visited_t &visited) const;
+
     virtual ~Playable() = default;
 };
 
 class Piece : public Playable {
+public:
+    size_t trackCount() const noexcept override;
+
+    // Appends what play() would output and returns true, or returns false
+    // when the piece can only be played directly.
+    virtual bool render(std::string &output) const;
+};
+
+class CompositePlayable;
+
+// Single insert or remove within CompositePlayable::applyBatch. Positions
+// refer to the composite as it was before the batch.
+class CompositeEdit {
+    enum class Kind {
+        INSERT,
+        REMOVE
+    };
+
+    Kind kind;
+    size_t position;
+    std::shared_ptr<Playable> elem;
+
+    CompositeEdit(Kind kind, size_t position, std::shared_ptr<Playable> elem)
+            : kind(kind), position(position), elem(std::move(elem)) {}
+
+    friend class CompositePlayable;
+
+public:
+    static CompositeEdit insert(std::shared_ptr<Piece> elem,
+                                size_t position);
+
+    static CompositeEdit insert(std::shared_ptr<CompositePlayable> elem,
+                                size_t position);
+
+    static CompositeEdit remove(size_t position);
 };
 
 class CompositePlayable : public Playable {
@@ -24,16 +78,68 @@ protected:
 
     std::vector<playable_ptr> child_components;
     std::vector<CompositePlayable *> child_composites;
+    std::vector<std::pair<CompositePlayable *, size_t>> parents;
+
+    size_t track_count = 0;
+    ptrdiff_t pending_tracks = 0;
+    // Fenwick tree over the children's track counts in play order, and
+    // the play order positions of every child composite, so that changes
+    // below a child update it in O(log fanout) per occurrence.
+    mutable std::vector<size_t> track_tree;
+    mutable std::unordered_map<const CompositePlayable *,
+            std::vector<size_t>> played_composites;
+    mutable bool track_tree_valid = false;
 
     size_t size() const;
 
     bool reachable(CompositePlayable *looked_up) const;
 
+    bool reachable(CompositePlayable *looked_up,
+                   std::unordered_set<const CompositePlayable *> &visited) const;
+
+    void addParent(CompositePlayable *parent);
+
+    void removeParent(CompositePlayable *parent) noexcept;
+
+    void collectAncestors(std::vector<CompositePlayable *> &order,
+                          std::unordered_set<const CompositePlayable *> &visited);
+
+    // This composite followed by every distinct ancestor, each one before
+    // its own parents.
+    std::vector<CompositePlayable *> ancestorsInOrder();
+
+    // Adds delta tracks here and passes the accumulated change up the
+    // ancestors, visiting each of them once.
+    void shiftTrackCount(const std::vector<CompositePlayable *> &ancestors,
+                         ptrdiff_t delta) noexcept;
+
+    void invalidateTrackOffsets() const noexcept;
+
+    void shiftTrackOffsets(const CompositePlayable *child,
+                           ptrdiff_t shift) const noexcept;
+
+    // Index in child_components of the child played at played_position.
+    virtual size_t playedPosition(size_t played_position) const;
+
+    void buildTrackOffsets() const;
+
+    size_t playedChildAt(size_t &position) const;
+
 public:
+    CompositePlayable() = default;
+
+    CompositePlayable(const CompositePlayable &) = delete;
+
+    CompositePlayable &operator=(const CompositePlayable &) = delete;
+
+    ~CompositePlayable() override;
+
     virtual void add(piece_ptr elem, size_t position);
 
     virtual void add(piece_ptr elem);
 
+    virtual void add(const std::vector<piece_ptr> &elems);
+
     virtual void add(composite_ptr elem, size_t position);
 
     virtual void add(composite_ptr elem);
@@ -41,6 +147,28 @@ public:
     virtual void remove(size_t position);
 
     virtual void remove();
+
+    // Applies all edits in one pass, or none of them if any is out of
+    // bounds, inserts a null element, removes a position twice or would
+    // create a loop. Inserts at the same position keep their order in the
+    // batch and come before the element previously at that position.
+    virtual void applyBatch(const std::vector<CompositeEdit> &edits);
+
+    size_t trackCount() const noexcept override;
+
+    MemoryUsage memoryUsage() const override;
+
+    void collectMemoryUsage(MemoryUsage &usage,
+                            visited_t &visited) const override;
+
+    // Piece played as the track with the given overall position, found
+    // through the nested composites in O(depth * log(fanout)). Edits below
+    // a composite keep its index up to date; an edit of its own children
+    // or play mode makes the next seek rebuild it in O(fanout).
+    piece_ptr trackAt(size_t position) const;
+
+    // Plays what play() would output from the given track onwards.
+    virtual void playFrom(size_t position) const = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -23,4 +23,25 @@ public:
     }
 };
 
+class ConflictingEditException : public PlayableCompositeException {
+public:
+    const char *what() const noexcept override {
+        return "batch removes the same position twice";
+    }
+};
+
+class NullElementException : public PlayableCompositeException {
+public:
+    const char *what() const noexcept override {
+        return "element is null";
+    }
+};
+
+class UnsupportedSeekException : public PlayableCompositeException {
+public:
+    const char *what() const noexcept override {
+        return "seeking is not supported in this play mode";
+    }
+};
+
 #endif
\ No newline at end of file
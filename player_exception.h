@@ -29,4 +29,18 @@ public:
     }
 };
 
+class RecordTooLongException : public PlayerException {
+public:
+    const char *what() const noexcept override {
+        return "record too long";
+    }
+};
+
+class NoPendingRecordException : public PlayerException {
+public:
+    const char *what() const noexcept override {
+        return "no pending record";
+    }
+};
+
 #endif
\ No newline at end of file
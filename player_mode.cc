@@ -2,10 +2,19 @@
 
 using collection_t = std::vector<std::shared_ptr<Playable>>;
 
+size_t PlayMode::originalPosition(size_t, size_t) const {
+    throw UnsupportedSeekException();
+}
+
 collection_t SequenceMode::orderTracks(const collection_t &tracks) {
     return collection_t(tracks);
 }
 
+size_t SequenceMode::originalPosition(size_t played_position,
+                                      size_t) const {
+    return played_position;
+}
+
 collection_t ShuffleMode::orderTracks(const collection_t &tracks) {
     collection_t result(tracks);
 
@@ -26,6 +35,15 @@ collection_t OddEvenMode::orderTracks(const collection_t &tracks) {
     return result;
 }
 
+size_t OddEvenMode::originalPosition(size_t played_position,
+                                     size_t size) const {
+    size_t odd_count = size / 2;
+
+    if (played_position < odd_count)
+        return 2 * played_position + 1;
+    return 2 * (played_position - odd_count);
+}
+
 std::shared_ptr<PlayMode> createSequenceMode() {
     return std::make_shared<SequenceMode>();
 }
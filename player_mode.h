@@ -13,12 +13,20 @@ protected:
 public:
     virtual collection_t orderTracks(const collection_t &tracks) = 0;
 
+    // Index in the original collection of the track played at
+    // played_position; modes without a fixed order do not support it.
+    virtual size_t originalPosition(size_t played_position,
+                                    size_t size) const;
+
     virtual ~PlayMode() = default;
 };
 
 class SequenceMode : public PlayMode {
 public:
     collection_t orderTracks(const collection_t &tracks) override;
+
+    size_t originalPosition(size_t played_position,
+                            size_t size) const override;
 };
 
 class ShuffleMode : public PlayMode {
@@ -34,6 +42,9 @@ public:
 class OddEvenMode : public PlayMode {
 public:
     collection_t orderTracks(const collection_t &tracks) override;
+
+    size_t originalPosition(size_t played_position,
+                            size_t size) const override;
 };
 
 
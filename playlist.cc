@@ -1,4 +1,65 @@
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "playlist.h"
+#include "spsc_queue.h"
+
+namespace {
+    struct StagedTrack {
+        std::string rendered;
+        std::shared_ptr<Playable> deferred;
+        bool last = false;
+    };
+
+    struct StagingCancelled {};
+}
+
+class LookaheadStager {
+    const size_t byte_budget;
+    size_t staged_bytes = 0;
+    std::mutex bytes_mutex;
+    std::condition_variable bytes_released;
+
+public:
+    SpscQueue<StagedTrack> tracks;
+    std::atomic<bool> stop{false};
+    std::exception_ptr failure;
+
+    LookaheadStager(size_t window, size_t byte_budget)
+            : byte_budget(byte_budget)
+            , tracks(window) {}
+
+    // Waits until the rendered bytes fit in the budget; a track larger than
+    // the whole budget is let through alone.
+    void push(StagedTrack &track) {
+        size_t size = track.rendered.size();
+        {
+            std::unique_lock<std::mutex> lock(bytes_mutex);
+            bytes_released.wait(lock, [&] {
+                return stop.load() || staged_bytes == 0
+                       || staged_bytes + size <= byte_budget;
+            });
+            if (stop.load()) throw StagingCancelled();
+            staged_bytes += size;
+        }
+
+        if (!tracks.push(track, stop)) throw StagingCancelled();
+    }
+
+    void release(const StagedTrack &track) {
+        std::lock_guard<std::mutex> lock(bytes_mutex);
+        staged_bytes -= track.rendered.size();
+        bytes_released.notify_one();
+    }
+
+    void cancel() {
+        stop.store(true);
+        tracks.wake();
+
+        std::lock_guard<std::mutex> lock(bytes_mutex);
+        bytes_released.notify_all();
+    }
+};
 
 size_t File::findColon(const std::string &line) const noexcept {
     for (size_t i = 0; i < line.size(); i++) {
@@ -70,9 +131,82 @@ const std::string &File::getContents() const noexcept {
 
 void Playlist::setMode(const playmode_ptr &mode) noexcept {
     this->mode = mode;
+    invalidateTrackOffsets();
+}
+
+size_t Playlist::playedPosition(size_t played_position) const {
+    return mode->originalPosition(played_position, size());
+}
+
+void Playlist::setLookahead(size_t window, size_t byte_budget) noexcept {
+    lookahead = window;
+    lookahead_bytes = byte_budget;
+}
+
+void Playlist::stage(LookaheadStager &stager) const {
+    StagedTrack header;
+    header.rendered = "Playlist [" + name + "]\n";
+    stager.push(header);
+
+    std::vector<playable_ptr> ordered_tracks =
+            mode->orderTracks(child_components);
+
+    for (auto &element : ordered_tracks) {
+        if (auto playlist = dynamic_cast<const Playlist *>(element.get())) {
+            playlist->stage(stager);
+            continue;
+        }
+
+        StagedTrack track;
+        auto piece = dynamic_cast<const Piece *>(element.get());
+        if (piece == nullptr || !piece->render(track.rendered))
+            track.deferred = element;
+        stager.push(track);
+    }
+}
+
+void Playlist::playAhead() const {
+    LookaheadStager stager(lookahead, lookahead_bytes);
+
+    std::thread worker([this, &stager] {
+        try {
+            stage(stager);
+            StagedTrack end;
+            end.last = true;
+            stager.push(end);
+        } catch (StagingCancelled const &) {
+        } catch (...) {
+            stager.failure = std::current_exception();
+            stager.cancel();
+        }
+    });
+
+    try {
+        StagedTrack track;
+        while (stager.tracks.pop(track, stager.stop) && !track.last) {
+            if (track.deferred)
+                track.deferred->play();
+            else
+                std::cout.write(track.rendered.data(), track.rendered.size());
+            stager.release(track);
+        }
+    } catch (...) {
+        stager.cancel();
+        worker.join();
+        throw;
+    }
+
+    worker.join();
+    std::cout.flush();
+    if (stager.failure) std::rethrow_exception(stager.failure);
 }
 
 void Playlist::play() const {
+    if (lookahead > 0) {
+        playAhead();
+        return;
+    }
+
     std::cout << "Playlist [" << name << "]" << std::endl;
 
     std::vector<playable_ptr> ordered_tracks =
@@ -82,28 +216,23 @@ void Playlist::play() const {
         element->play();
 }
 
-Player::Player() {
-    openers["audio"] = std::make_shared<SongOpener>();
-    openers["video"] = std::make_shared<MovieOpener>();
-}
-
-Player::Player(std::unordered_map<std::string,
-        std::shared_ptr<Opener>> otherOpeners) {
-    openers["audio"] = std::make_shared<SongOpener>();
-    openers["video"] = std::make_shared<MovieOpener>();
-    openers.merge(otherOpeners);
-}
+void Playlist::playFrom(size_t position) const {
+    size_t played = playedChildAt(position);
+    const playable_ptr &resumed = child_components[playedPosition(played)];
 
-std::shared_ptr<Piece> Player::openFile(const File &file) {
-    auto it = openers.find(file.getType());
-    if (it == openers.end())
-        throw UnsupportedTypeException();
+    auto composite = dynamic_cast<const CompositePlayable *>(resumed.get());
+    if (composite != nullptr)
+        composite->playFrom(position);
+    else
+        resumed->play();
 
-    return openers[file.getType()]->open(file.getMetadata(),
-                                         file.getContents());
+    for (size_t i = played + 1; i < size(); i++)
+        child_components[playedPosition(i)]->play();
 }
 
-std::shared_ptr<Playlist>
-Player::createPlaylist(const std::string &name) const {
-    return std::make_shared<Playlist>(name);
+MemoryUsage Playlist::memoryUsage() const {
+    MemoryUsage usage = CompositePlayable::memoryUsage();
+    usage.metadata += heapBytes(name);
+    usage.structure += sizeof(Playlist);
+    return usage;
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
 #define _PLAYLIST_H
 
 #include <iostream>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 #include <boost/algorithm/string.hpp>
 #include "player_exception.h"
 #include "playable_exception.h"
@@ -29,11 +32,22 @@ public:
     const std::string &getContents() const noexcept;
 };
 
+class LookaheadStager;
+
 class Playlist : public CompositePlayable {
     using playmode_ptr = std::shared_ptr<PlayMode>;
 
     playmode_ptr mode;
     const std::string name;
+    size_t lookahead = 0;
+    size_t lookahead_bytes = 0;
+
+    void stage(LookaheadStager &stager) const;
+
+    void playAhead() const;
+
+protected:
+    size_t playedPosition(size_t played_position) const override;
 
 public:
     explicit Playlist(std::string name) :
@@ -42,22 +56,109 @@ public:
 
     void setMode(const playmode_ptr &mode) noexcept;
 
+    static const size_t DEFAULT_LOOKAHEAD_BYTES = 1 << 20;
+
+    // With a non-zero window, play() prepares up to that many upcoming
+    // tracks on a background thread while the current one is output.
+    // Prepared tracks waiting for output take at most byte_budget bytes,
+    // or a single track when it alone is larger; the worker additionally
+    // holds the one track it is preparing.
+    void setLookahead(size_t window,
+                      size_t byte_budget = DEFAULT_LOOKAHEAD_BYTES) noexcept;
+
     void play() const override;
+
+    void playFrom(size_t position) const override;
+
+    MemoryUsage memoryUsage() const override;
 };
 
-class Player {
+// Player whose openers for StaticOpeners::type_tag are fixed at compile
+// time and dispatched without hashing or virtual calls. Other types fall
+// back to the openers registered at runtime.
+template <typename... StaticOpeners>
+class BasicPlayer {
 private:
+    std::tuple<StaticOpeners...> static_openers;
     std::unordered_map<std::string, std::shared_ptr<Opener>> openers;
 
-public:
-    Player();
+    static constexpr bool distinctTags() {
+        std::string_view tags[] = {StaticOpeners::type_tag..., ""};
+
+        for (size_t i = 0; i < sizeof...(StaticOpeners); i++)
+            for (size_t j = i + 1; j < sizeof...(StaticOpeners); j++)
+                if (tags[i] == tags[j])
+                    return false;
+        return true;
+    }
+
+    static_assert(distinctTags(), "static opener type tags must be distinct");
 
-    explicit Player(std::unordered_map<std::string,
-            std::shared_ptr<Opener>> otherOpeners);
+    template <typename StaticOpener>
+    static StaticOpener makeStaticOpener(ContentStorage storage) {
+        if constexpr (std::is_constructible_v<StaticOpener, ContentStorage>)
+            return StaticOpener(storage);
+        else
+            return StaticOpener();
+    }
 
-    std::shared_ptr<Piece> openFile(const File &file);
+    template <typename StaticOpener>
+    bool openStatic(const File &file, std::shared_ptr<Piece> &piece) const {
+        if (file.getType() != StaticOpener::type_tag) return false;
 
-    std::shared_ptr<Playlist> createPlaylist(const std::string &name) const;
+        piece = std::get<StaticOpener>(static_openers).StaticOpener::open(
+                file.getMetadata(), file.getContents());
+        return true;
+    }
+
+public:
+    explicit BasicPlayer(ContentStorage storage = ContentStorage::PLAIN)
+            : static_openers(makeStaticOpener<StaticOpeners>(storage)...) {}
+
+    explicit BasicPlayer(std::unordered_map<std::string,
+            std::shared_ptr<Opener>> otherOpeners,
+            ContentStorage storage = ContentStorage::PLAIN)
+            : static_openers(makeStaticOpener<StaticOpeners>(storage)...)
+            , openers(std::move(otherOpeners))
+    {
+        (openers.erase(std::string(StaticOpeners::type_tag)), ...);
+    }
+
+    std::shared_ptr<Piece> openFile(const File &file) {
+        std::shared_ptr<Piece> piece;
+        if ((openStatic<StaticOpeners>(file, piece) || ...))
+            return piece;
+
+        auto it = openers.find(file.getType());
+        if (it == openers.end())
+            throw UnsupportedTypeException();
+
+        return it->second->open(file.getMetadata(), file.getContents());
+    }
+
+    std::shared_ptr<Playlist> createPlaylist(const std::string &name) const {
+        return std::make_shared<Playlist>(name);
+    }
+
+    // Runtime openers are counted at their base class size.
+    MemoryUsage memoryUsage() const {
+        using node_t = typename decltype(openers)::value_type;
+
+        MemoryUsage usage;
+        usage.structure = sizeof(BasicPlayer)
+                          + openers.bucket_count() * sizeof(void *)
+                          + openers.size() * (sizeof(node_t) + sizeof(void *)
+                                              + sizeof(size_t));
+
+        for (auto &opener : openers) {
+            usage.metadata += heapBytes(opener.first);
+            usage.structure += SHARED_CONTROL_BLOCK_BYTES + sizeof(Opener);
+        }
+
+        return usage;
+    }
 };
 
+using Player = BasicPlayer<SongOpener, MovieOpener>;
+
 #endif
\ No newline at end of file
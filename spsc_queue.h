@@ -0,0 +1,136 @@
+#ifndef PLAYLIST_SPSC_QUEUE_H
+#define PLAYLIST_SPSC_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// A side that cannot proceed spins briefly and then sleeps until the other
+// side makes room or data, or until wake() is called.
+template <typename T>
+class SpscQueue {
+    static const int SPIN_LIMIT = 64;
+
+    std::vector<T> slots;
+
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+
+    std::atomic<bool> producer_waiting{false};
+    std::atomic<bool> consumer_waiting{false};
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    size_t next(size_t index) const noexcept {
+        return index + 1 == slots.size() ? 0 : index + 1;
+    }
+
+    bool insert(T &value) {
+        size_t current = tail.load(std::memory_order_relaxed);
+        size_t following = next(current);
+        if (following == head.load(std::memory_order_acquire))
+            return false;
+
+        slots[current] = std::move(value);
+        tail.store(following, std::memory_order_release);
+        return true;
+    }
+
+    bool extract(T &value) {
+        size_t current = head.load(std::memory_order_relaxed);
+        if (current == tail.load(std::memory_order_acquire))
+            return false;
+
+        value = std::move(slots[current]);
+        slots[current] = T();
+        head.store(next(current), std::memory_order_release);
+        return true;
+    }
+
+    // Pairs with the fence in block(): either the sleeper sees our change
+    // on its last attempt, or we see its flag and notify it.
+    void wakeIfWaiting(std::atomic<bool> &waiting) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed)) wake();
+    }
+
+    template <typename Attempt>
+    bool block(Attempt attempt, std::atomic<bool> &waiting,
+               const std::atomic<bool> &stop) {
+        for (int i = 0; i < SPIN_LIMIT; i++) {
+            if (attempt()) return true;
+            if (stop.load(std::memory_order_relaxed)) return false;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (attempt()) break;
+            if (stop.load()) {
+                waiting.store(false, std::memory_order_relaxed);
+                return false;
+            }
+            changed.wait(lock);
+        }
+
+        waiting.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+public:
+    explicit SpscQueue(size_t capacity)
+            : slots(capacity + 1) {}
+
+    bool tryPush(T &value) {
+        if (!insert(value)) return false;
+        wakeIfWaiting(consumer_waiting);
+        return true;
+    }
+
+    bool tryPop(T &value) {
+        if (!extract(value)) return false;
+        wakeIfWaiting(producer_waiting);
+        return true;
+    }
+
+    // Waits until the value fits or stop becomes set; returns whether the
+    // value was pushed. Whoever sets stop must call wake() afterwards.
+    bool push(T &value, const std::atomic<bool> &stop) {
+        if (!block([&] { return insert(value); }, producer_waiting, stop))
+            return false;
+        wakeIfWaiting(consumer_waiting);
+        return true;
+    }
+
+    bool pop(T &value, const std::atomic<bool> &stop) {
+        if (!block([&] { return extract(value); }, consumer_waiting, stop))
+            return false;
+        wakeIfWaiting(producer_waiting);
+        return true;
+    }
+
+    void wake() {
+        std::lock_guard<std::mutex> lock(mutex);
+        changed.notify_all();
+    }
+
+    size_t size() const noexcept {
+        size_t current_head = head.load(std::memory_order_acquire);
+        size_t current_tail = tail.load(std::memory_order_acquire);
+        return current_tail >= current_head
+               ? current_tail - current_head
+               : current_tail + slots.size() - current_head;
+    }
+
+    size_t capacity() const noexcept {
+        return slots.size() - 1;
+    }
+};
+
+#endif
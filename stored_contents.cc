@@ -0,0 +1,214 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "stored_contents.h"
+#include "player_exception.h"
+#include "memory_usage.h"
+
+namespace {
+    const size_t MIN_MATCH = 4;
+    const size_t MAX_OFFSET = 65535;
+    const unsigned HASH_BITS = 12;
+    // No encoded byte expands to more than this many output bytes.
+    const size_t MAX_EXPANSION = 255;
+
+    uint32_t read32(const char *p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    size_t hash(uint32_t value) {
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    void writeLength(std::string &output, size_t length) {
+        while (length >= 255) {
+            output.push_back(static_cast<char>(255));
+            length -= 255;
+        }
+        output.push_back(static_cast<char>(length));
+    }
+
+    void writeVarint(std::string &output, size_t value) {
+        while (value >= 0x80) {
+            output.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        output.push_back(static_cast<char>(value));
+    }
+
+    void writeSequence(std::string &output, const char *literals,
+                       size_t literal_length, size_t offset,
+                       size_t match_length) {
+        size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+        unsigned char token = static_cast<unsigned char>(
+                (std::min<size_t>(literal_length, 15) << 4)
+                | std::min<size_t>(match_code, 15));
+
+        output.push_back(static_cast<char>(token));
+        if (literal_length >= 15) writeLength(output, literal_length - 15);
+        output.append(literals, literal_length);
+
+        if (match_length == 0) return;
+
+        output.push_back(static_cast<char>(offset & 0xff));
+        output.push_back(static_cast<char>(offset >> 8));
+        if (match_code >= 15) writeLength(output, match_code - 15);
+    }
+
+    class Decoder {
+        const unsigned char *position;
+        const unsigned char *const end;
+
+    public:
+        explicit Decoder(const std::string &input)
+                : position(reinterpret_cast<const unsigned char *>(input.data()))
+                , end(position + input.size()) {}
+
+        bool done() const noexcept {
+            return position == end;
+        }
+
+        size_t remaining() const noexcept {
+            return end - position;
+        }
+
+        unsigned char byte() {
+            if (position == end) throw CorruptContentException();
+            return *position++;
+        }
+
+        size_t length(size_t base) {
+            if (base < 15) return base;
+
+            unsigned char next;
+            do {
+                next = byte();
+                base += next;
+            } while (next == 255);
+            return base;
+        }
+
+        size_t varint() {
+            size_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+                unsigned char next = byte();
+                value |= static_cast<size_t>(next & 0x7f) << shift;
+                if (!(next & 0x80)) return value;
+            }
+            throw CorruptContentException();
+        }
+
+        const char *take(size_t count) {
+            if (count > remaining()) throw CorruptContentException();
+            auto taken = reinterpret_cast<const char *>(position);
+            position += count;
+            return taken;
+        }
+    };
+}
+
+std::string compressContents(const std::string &input) {
+    std::string output;
+    output.reserve(input.size() / 2 + 16);
+    writeVarint(output, input.size());
+
+    const char *data = input.data();
+    size_t size = input.size();
+    size_t anchor = 0, i = 0;
+    std::vector<int64_t> table(size_t(1) << HASH_BITS, -1);
+
+    while (size >= MIN_MATCH && i <= size - MIN_MATCH) {
+        uint32_t sequence = read32(data + i);
+        size_t slot = hash(sequence);
+        int64_t candidate = table[slot];
+        table[slot] = static_cast<int64_t>(i);
+
+        if (candidate < 0 || i - candidate > MAX_OFFSET
+            || read32(data + candidate) != sequence) {
+            i++;
+            continue;
+        }
+
+        size_t match_length = MIN_MATCH;
+        while (i + match_length < size
+               && data[candidate + match_length] == data[i + match_length])
+            match_length++;
+
+        writeSequence(output, data + anchor, i - anchor, i - candidate,
+                      match_length);
+        i += match_length;
+        anchor = i;
+    }
+
+    writeSequence(output, data + anchor, size - anchor, 0, 0);
+    return output;
+}
+
+void decompressContents(const std::string &input, std::string &output) {
+    Decoder decoder(input);
+    size_t expected = decoder.varint();
+    if (expected > decoder.remaining() * MAX_EXPANSION)
+        throw CorruptContentException();
+
+    output.clear();
+    output.reserve(expected);
+
+    while (true) {
+        unsigned char token = decoder.byte();
+        size_t literal_length = decoder.length(token >> 4);
+        output.append(decoder.take(literal_length), literal_length);
+        if (output.size() > expected) throw CorruptContentException();
+
+        if (decoder.done()) break;
+
+        size_t offset = decoder.byte();
+        offset |= static_cast<size_t>(decoder.byte()) << 8;
+        size_t match_length = decoder.length(token & 0x0f) + MIN_MATCH;
+
+        if (offset == 0 || offset > output.size()
+            || match_length > expected - output.size())
+            throw CorruptContentException();
+
+        size_t from = output.size() - offset;
+        for (size_t k = 0; k < match_length; k++)
+            output.push_back(output[from + k]);
+    }
+
+    if (output.size() != expected) throw CorruptContentException();
+}
+
+StoredContents::StoredContents(std::string contents, ContentStorage storage)
+        : data(std::move(contents))
+        , compressed(false)
+{
+    if (storage != ContentStorage::COMPRESSED) return;
+
+    std::string packed = compressContents(data);
+    if (packed.size() < data.size()) {
+        packed.shrink_to_fit();
+        data = std::move(packed);
+        compressed = true;
+    }
+}
+
+const std::string &StoredContents::get() const {
+    if (!compressed) return data;
+
+    thread_local std::string scratch;
+    decompressContents(data, scratch);
+    return scratch;
+}
+
+size_t StoredContents::storedSize() const noexcept {
+    return data.size();
+}
+
+size_t StoredContents::heapBytes() const noexcept {
+    return ::heapBytes(data);
+}
+
+bool StoredContents::isCompressed() const noexcept {
+    return compressed;
+}
@@ -0,0 +1,38 @@
+#ifndef PLAYLIST_STORED_CONTENTS_H
+#define PLAYLIST_STORED_CONTENTS_H
+
+#include <string>
+
+enum class ContentStorage {
+    PLAIN,
+    COMPRESSED
+};
+
+// LZ77 block codec with an LZ4-like sequence layout: no dictionary, no
+// entropy coding, tuned for decompression speed over ratio.
+std::string compressContents(const std::string &input);
+
+void decompressContents(const std::string &input, std::string &output);
+
+// Piece contents held either verbatim or compressed. Compression is kept
+// only when it actually saves space.
+class StoredContents {
+    std::string data;
+    bool compressed;
+
+public:
+    StoredContents(std::string contents, ContentStorage storage);
+
+    // Compressed contents are expanded into a per-thread scratch buffer,
+    // valid until the next get() on the same thread. Throws
+    // CorruptContentException if the compressed data is damaged.
+    const std::string &get() const;
+
+    size_t storedSize() const noexcept;
+
+    size_t heapBytes() const noexcept;
+
+    bool isCompressed() const noexcept;
+};
+
+#endif
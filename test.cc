@@ -1,7 +1,10 @@
-#include "playlist.h"
+#include "lib_playlist.h"
 #include  <cassert>
+#include <random>
+#include <sstream>
 
-bool add_file(Player player, std::shared_ptr<Playlist> playlist, const char* file_content) {
+template <typename AnyPlayer>
+bool add_file(AnyPlayer player, std::shared_ptr<Playlist> playlist, const char* file_content) {
     try {
         auto file = File(file_content);
         auto opened_file = player.openFile(file);
@@ -15,10 +18,30 @@ bool add_file(Player player, std::shared_ptr<Playlist> playlist, const char* fil
     }
 }
 
+// Returns what playing() writes to std::cout.
+template <typename Playing>
+std::string capture_output(Playing playing) {
+    std::ostringstream captured;
+    auto old_buffer = std::cout.rdbuf(captured.rdbuf());
+    try {
+        playing();
+    } catch (...) {
+        std::cout.rdbuf(old_buffer);
+        throw;
+    }
+    std::cout.rdbuf(old_buffer);
+    return captured.str();
+}
+
 class InheritedOpener : public SongOpener {
 
 };
 
+class PodcastOpener : public SongOpener {
+public:
+    static constexpr std::string_view type_tag = "podcast";
+};
+
 int main() {
     Player player{};
 
@@ -156,5 +179,415 @@ int main() {
 
     playinherit->play();
 
+    {
+        FileReader reader(32, 2);
+        std::string stream = "audio|artist:A|title:B|Song0\naudio|artist:C|ti"
+                             "tle:D|Song1\r\n\naudio|artist:E|title:F|way too long"
+                             " to fit\nvideo|title:X|year:1|Fbat\naudio|artist:G";
+        auto streamed = player.createPlaylist("streamed");
+        size_t offset = 0, chunk = 5, errors = 0;
+
+        while (offset < stream.size() || reader.hasNext()) {
+            size_t length = std::min(chunk, stream.size() - offset);
+            offset += reader.feed(stream.data() + offset, length);
+            assert(reader.pending() <= 2);
+
+            while (reader.hasNext()) {
+                try {
+                    streamed->add(player.openFile(reader.next()));
+                } catch (PlayerException const &e) {
+                    errors++;
+                }
+            }
+        }
+        reader.finish();
+        while (reader.hasNext()) {
+            try {
+                streamed->add(player.openFile(reader.next()));
+            } catch (PlayerException const &e) {
+                errors++;
+            }
+        }
+
+        assert(errors == 2);
+        streamed->play();
+    }
+
+    {
+        std::string stream;
+        for (int i = 0; i < 1000; i++) {
+            if (i % 100 == 7)
+                stream += "audio|artist:A|Song" + std::to_string(i) + "\n";
+            else
+                stream += "audio|artist:A|title:" + std::to_string(i)
+                          + "|Song" + std::to_string(i) + "\n";
+        }
+        std::istringstream input(stream);
+
+        auto ingested = player.createPlaylist("ingested");
+        IngestPipeline pipeline([&player](const File &file) {
+            return player.openFile(file);
+        }, ingested, 4, 100, 16);
+        pipeline.run(input);
+
+        IngestStats stats = pipeline.stats();
+        assert(stats.bytes_read == stream.size());
+        assert(stats.records_parsed == 1000);
+        assert(stats.records_rejected == 10);
+        assert(stats.pieces_appended == 990);
+        assert(stats.chunk_queue_depth == 0 && stats.piece_queue_depth == 0);
+
+        std::string captured = capture_output([&] { ingested->play(); });
+        assert(captured.rfind("Playlist [ingested]\nSong [A, 0]: Song0\n", 0)
+               == 0);
+        assert(captured.find("Song [A, 6]: Song6\nSong [A, 8]: Song8")
+               != std::string::npos);
+
+        auto unbuffered = player.createPlaylist("unbuffered");
+        std::istringstream line("audio|artist:A|title:B|C\n");
+        IngestPipeline minimal([&player](const File &file) {
+            return player.openFile(file);
+        }, unbuffered, 0, 0, 0);
+        minimal.run(line);
+        assert(unbuffered->trackCount() == 1);
+    }
+
+    {
+        std::string samples[] = {
+                "", "a", "abcabcabcabcabcabcabcabcabcabcabcabc",
+                std::string(1000, 'x') + "tail",
+                "The quick brown fox jumps over the lazy dog. "
+                "The quick brown fox jumps over the lazy dog!"
+        };
+        std::string expanded;
+        for (const std::string &sample : samples) {
+            decompressContents(compressContents(sample), expanded);
+            assert(expanded == sample);
+        }
+
+        std::string lyrics;
+        for (int i = 0; i < 50; i++)
+            lyrics += "I see trees of green, red roses too. ";
+        StoredContents stored(lyrics, ContentStorage::COMPRESSED);
+        assert(stored.isCompressed() && stored.storedSize() < lyrics.size() / 4);
+        assert(stored.get() == lyrics);
+        assert(!StoredContents("short", ContentStorage::COMPRESSED).isCompressed());
+
+        std::string damaged = compressContents(lyrics);
+        damaged.resize(damaged.size() / 2);
+        try {
+            decompressContents(damaged, expanded);
+            assert(false);
+        } catch (CorruptContentException const &e) {}
+
+        std::string oversized(9, '\xff');
+        oversized += "\x01\x10" "a";
+        try {
+            decompressContents(oversized, expanded);
+            assert(false);
+        } catch (CorruptContentException const &e) {}
+
+        Player compressing(ContentStorage::COMPRESSED);
+        auto packed = compressing.createPlaylist("compressed");
+        assert(add_file(compressing, packed, ("audio|artist:A|title:B|" + lyrics).c_str()));
+        assert(add_file(compressing, packed, "video|title:C|year:1|Ybbc ybbc ybbc ybbc ybbc"));
+
+        std::string captured = capture_output([&] { packed->play(); });
+        assert(captured == "Playlist [compressed]\nSong [A, B]: " + lyrics
+                                 + "\nMovie [C, 1]: Loop loop loop loop loop\n");
+    }
+
+    {
+        auto song = [&player](int i) {
+            return player.openFile(File("audio|artist:S|title:" + std::to_string(i)
+                                        + "|Song" + std::to_string(i)));
+        };
+
+        auto root = player.createPlaylist("root");
+        auto left = player.createPlaylist("left");
+        auto shared = player.createPlaylist("shared");
+        auto empty = player.createPlaylist("empty");
+
+        for (int i = 0; i < 5; i++) shared->add(song(i));
+        left->add(song(10));
+        left->add(shared);
+        left->add(empty);
+        left->add(song(11));
+        root->add(song(20));
+        root->add(left);
+        root->add(shared);
+        root->add(song(21));
+        assert(root->trackCount() == 14);
+
+        shared->setMode(createOddEvenMode());
+        left->setMode(createOddEvenMode());
+        shared->add(song(5), 2);
+        shared->remove(0);
+        assert(shared->trackCount() == 5 && root->trackCount() == 14);
+
+        std::string full = capture_output([&] { root->play(); });
+        std::vector<size_t> track_lines;
+        for (size_t at = full.find('\n') + 1; at < full.size();
+             at = full.find('\n', at) + 1)
+            if (full.compare(at, 4, "Song") == 0) track_lines.push_back(at);
+        assert(track_lines.size() == root->trackCount());
+
+        for (size_t n = 0; n < root->trackCount(); n++) {
+            std::string track = capture_output([&] { root->trackAt(n)->play(); });
+            assert(full.compare(track_lines[n], track.size(), track) == 0);
+            assert(capture_output([&] { root->playFrom(n); })
+                   == full.substr(track_lines[n]));
+        }
+
+        try {
+            root->trackAt(14);
+            assert(false);
+        } catch (OutOfBoundsException const &e) {}
+
+        left->setMode(createShuffleMode(0));
+        try {
+            root->trackAt(3);
+            assert(false);
+        } catch (UnsupportedSeekException const &e) {}
+        assert(root->trackAt(0) != nullptr);
+
+        left->remove(1);
+        assert(root->trackCount() == 9);
+
+        left->setMode(createOddEvenMode());
+        std::mt19937 edits(5);
+        std::shared_ptr<Playlist> editable[] = {shared, left, empty};
+        for (int round = 0; round < 30; round++) {
+            auto &target = editable[edits() % 3];
+            if (target->trackCount() > 0 && edits() % 3 == 0)
+                target->remove();
+            else
+                target->add(song(100 + round), 0);
+
+            full = capture_output([&] { root->play(); });
+            track_lines.clear();
+            for (size_t at = full.find('\n') + 1; at < full.size();
+                 at = full.find('\n', at) + 1)
+                if (full.compare(at, 4, "Song") == 0) track_lines.push_back(at);
+            assert(track_lines.size() == root->trackCount());
+
+            for (size_t n = 0; n < root->trackCount(); n++) {
+                std::string track = capture_output([&] { root->trackAt(n)->play(); });
+                assert(full.compare(track_lines[n], track.size(), track) == 0);
+            }
+        }
+
+        std::vector<std::shared_ptr<Playlist>> chain{player.createPlaylist("0")};
+        for (int depth = 1; depth <= 40; depth++) {
+            auto upper = player.createPlaylist(std::to_string(depth));
+            upper->add(chain.back());
+            upper->add(chain.back());
+            chain.push_back(upper);
+        }
+        chain.front()->add(song(0));
+        chain.front()->add(song(1));
+        assert(chain.back()->trackCount() == size_t(2) << 40);
+        chain.front()->remove(0);
+        assert(chain.back()->trackCount() == size_t(1) << 40);
+        assert(chain.back()->trackAt((size_t(1) << 40) - 1) != nullptr);
+    }
+
+    {
+        class Jingle : public Piece {
+        public:
+            void play() const override {
+                std::cout << "Jingle" << std::endl;
+            }
+        };
+
+        auto outer = player.createPlaylist("outer");
+        auto inner = player.createPlaylist("inner");
+        for (int i = 0; i < 20; i++) {
+            assert(add_file(player, inner, ("audio|artist:In|title:" + std::to_string(i)
+                                            + "|Song" + std::to_string(i)).c_str()));
+            assert(add_file(player, outer, ("video|title:Out|year:" + std::to_string(i)
+                                            + "|Zbivr").c_str()));
+        }
+        outer->add(inner, 3);
+        outer->add(std::make_shared<Jingle>(), 7);
+        outer->add(inner);
+
+        auto played = [&](size_t window) {
+            outer->setLookahead(window);
+            outer->setMode(createShuffleMode(42));
+            inner->setMode(createShuffleMode(7));
+            return capture_output([&] { outer->play(); });
+        };
+
+        std::string expected = played(0);
+        assert(expected.find("Jingle\n") != std::string::npos);
+        assert(played(1) == expected);
+        assert(played(4) == expected);
+        assert(played(1000) == expected);
+
+        auto played_within = [&](size_t byte_budget) {
+            outer->setLookahead(8, byte_budget);
+            outer->setMode(createShuffleMode(42));
+            inner->setMode(createShuffleMode(7));
+            return capture_output([&] { outer->play(); });
+        };
+        assert(played_within(1) == expected);
+        assert(played_within(64) == expected);
+    }
+
+    {
+        auto song = [&player](const std::string &title) {
+            return player.openFile(File("audio|artist:B|title:" + title + "|x"));
+        };
+
+        auto batched = player.createPlaylist("batched");
+        auto sequential = player.createPlaylist("batched");
+        auto child = player.createPlaylist("child");
+        child->add(song("c0"));
+        child->add(song("c1"));
+        for (auto list : {batched, sequential}) {
+            for (int i = 0; i < 5; i++) list->add(song(std::to_string(i)));
+            list->add(child, 2);
+        }
+
+        auto inserted = song("new");
+        batched->applyBatch({
+                CompositeEdit::remove(2),
+                CompositeEdit::insert(inserted, 5),
+                CompositeEdit::insert(child, 0),
+                CompositeEdit::remove(0),
+                CompositeEdit::insert(song("end"), 6),
+                CompositeEdit::insert(inserted, 5),
+                CompositeEdit::remove(5),
+        });
+
+        sequential->remove(5);
+        sequential->add(inserted, 5);
+        sequential->add(inserted, 5);
+        sequential->add(song("end"));
+        sequential->remove(2);
+        sequential->remove(0);
+        sequential->add(child, 0);
+
+        assert(capture_output([&] { batched->play(); })
+               == capture_output([&] { sequential->play(); }));
+        assert(batched->trackCount() == 8 && batched->trackAt(1)->trackCount() == 1);
+
+        std::string before = capture_output([&] { batched->play(); });
+        auto rejected = [&](std::vector<CompositeEdit> edits) {
+            try {
+                batched->applyBatch(edits);
+                return false;
+            } catch (PlayableCompositeException const &e) {
+                return capture_output([&] { batched->play(); }) == before
+                       && batched->trackCount() == 8;
+            }
+        };
+        assert(rejected({CompositeEdit::remove(0), CompositeEdit::remove(7)}));
+        assert(rejected({CompositeEdit::remove(1), CompositeEdit::remove(1)}));
+        assert(rejected({CompositeEdit::insert(song("x"), 0),
+                         CompositeEdit::insert(song("y"), 8)}));
+        assert(rejected({CompositeEdit::remove(0), CompositeEdit::insert(batched, 0)}));
+        assert(rejected({CompositeEdit::insert(std::shared_ptr<Piece>(), 0)}));
+        for (auto adding : std::vector<std::function<void()>>{
+                [&] { batched->add(std::shared_ptr<Piece>()); },
+                [&] { batched->add(std::shared_ptr<Piece>(), 0); },
+                [&] { batched->add({song("z"), std::shared_ptr<Piece>()}); }}) {
+            try {
+                adding();
+                assert(false);
+            } catch (NullElementException const &e) {
+                assert(batched->trackCount() == 8);
+            }
+        }
+
+        auto parent = player.createPlaylist("parent");
+        parent->add(batched);
+        try {
+            child->applyBatch({CompositeEdit::insert(parent, 0)});
+            assert(false);
+        } catch (LoopingException const &e) {}
+
+        batched->applyBatch({CompositeEdit::remove(0)});
+        child->add(song("c2"));
+        assert(parent->trackCount() == 6);
+        child->applyBatch({CompositeEdit::insert(song("c3"), 0),
+                           CompositeEdit::remove(0)});
+        assert(sequential->trackCount() == 9 && parent->trackCount() == 6);
+    }
+
+    {
+        std::string lyrics;
+        for (int i = 0; i < 100; i++) lyrics += "Hello, Dolly! This is Louis, Dolly. ";
+        std::string description = "audio|artist:Louis Armstrong, the one and only|"
+                                  "title:Hello, Dolly!|" + lyrics;
+
+        auto song = player.openFile(File(description));
+        MemoryUsage song_usage = song->memoryUsage();
+        assert(song_usage.contents > lyrics.size());
+        assert(song_usage.metadata > 0 && song_usage.structure >= sizeof(Song));
+        assert(song->deepMemoryUsage().total() == song_usage.total());
+
+        Player compressing(ContentStorage::COMPRESSED);
+        auto packed = compressing.openFile(File(description));
+        assert(packed->memoryUsage().contents * 4 < song_usage.contents);
+        assert(packed->memoryUsage().metadata == song_usage.metadata);
+
+        auto top = player.createPlaylist("top");
+        auto shared = player.createPlaylist("shared");
+        shared->add(song);
+        shared->add(song);
+        top->add(shared);
+        top->add(shared);
+        top->add(song);
+
+        MemoryUsage shared_usage = shared->deepMemoryUsage();
+        assert(shared_usage.contents == song_usage.contents);
+        assert(shared_usage.total() == shared->memoryUsage().total()
+                                       + song_usage.total()
+                                       + SHARED_CONTROL_BLOCK_BYTES);
+
+        MemoryUsage top_usage = top->deepMemoryUsage();
+        assert(top_usage.contents == song_usage.contents);
+        assert(top_usage.total() == top->memoryUsage().total()
+                                    + shared_usage.total()
+                                    + SHARED_CONTROL_BLOCK_BYTES);
+        assert(top->memoryUsage().structure > sizeof(Playlist));
+        assert(player.memoryUsage().metadata == 0);
+        assert(richerPlayer.memoryUsage().structure > player.memoryUsage().structure);
+    }
+
+    {
+        std::unordered_map<std::string, std::shared_ptr<Opener>> runtime;
+        runtime["audio"] = std::make_shared<MovieOpener>();
+        runtime["copied_audio"] = std::make_shared<InheritedOpener>();
+        BasicPlayer<PodcastOpener, SongOpener, MovieOpener> extended{runtime};
+
+        auto mixed = extended.createPlaylist("mixed");
+        assert(add_file(extended, mixed, "podcast|artist:Host|title:Episode 1|Talk"));
+        assert(add_file(extended, mixed, "audio|artist:Band|title:Hit|Music"));
+        assert(add_file(extended, mixed, "copied_audio|artist:Band|title:Cover|Music"));
+        assert(add_file(extended, mixed, "video|title:Film|year:2000|Zbivr"));
+        assert(!add_file(extended, mixed, "mp3|artist:Band|title:Hit|Music"));
+        assert(mixed->trackCount() == 4);
+
+        std::istringstream input("podcast|artist:Host|title:Episode 2|More talk\n"
+                                 "copied_audio|artist:Band|title:Live|Music\n");
+        IngestPipeline pipeline([&extended](const File &file) {
+            return extended.openFile(file);
+        }, mixed);
+        pipeline.run(input);
+        assert(mixed->trackCount() == 6);
+
+        std::string captured = capture_output([&] { mixed->play(); });
+        assert(captured == "Playlist [mixed]\n"
+                                 "Song [Host, Episode 1]: Talk\n"
+                                 "Song [Band, Hit]: Music\n"
+                                 "Song [Band, Cover]: Music\n"
+                                 "Movie [Film, 2000]: Movie\n"
+                                 "Song [Host, Episode 2]: More talk\n"
+                                 "Song [Band, Live]: Music\n");
+    }
+
     return 0;
 }